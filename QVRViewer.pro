@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui opengl
+QT       += core gui opengl concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,10 +14,17 @@ TEMPLATE = app
 
 SOURCES += src/main.cpp\
     src/mainwindow.cpp \
-    src/vrview.cpp
+    src/vrview.cpp \
+    src/slideshow.cpp \
+    src/videodecoder.cpp
 
 HEADERS  += src/mainwindow.h \
+    src/hdrformats.h \
     src/modelformats.h \
+    src/panorama.h \
+    src/slideshow.h \
+    src/startup.h \
+    src/videodecoder.h \
     src/vrview.h
 
 FORMS    += src/mainwindow.ui
@@ -53,15 +60,21 @@ message("32 bit build")
         LIBS += -L$$PWD/extern/openvr/lib/win32/ \
                 -lopenvr_api -lopengl32
         copyToDestdir($${PWD}/extern/openvr/bin/win32/openvr_api.dll)
+        LIBS += -L$$PWD/extern/ffmpeg/lib/win32/ \
+                -lavformat -lavcodec -lswscale -lavutil
+        copyToDestdir($$files($${PWD}/extern/ffmpeg/bin/win32/*.dll))
     } else {
 message("64 bit build")
         LIBS += -L$$PWD/extern/openvr/lib/win64/ \
                 -lopenvr_api -lopengl32
         copyToDestdir($${PWD}/extern/openvr/bin/win64/openvr_api.dll)
+        LIBS += -L$$PWD/extern/ffmpeg/lib/win64/ \
+                -lavformat -lavcodec -lswscale -lavutil
+        copyToDestdir($$files($${PWD}/extern/ffmpeg/bin/win64/*.dll))
     }
 }
 
-INCLUDEPATH += $$PWD/extern/openvr/headers $$PWD/extern/glew/include
+INCLUDEPATH += $$PWD/extern/openvr/headers $$PWD/extern/glew/include $$PWD/extern/ffmpeg/include
 
 
 # from http://stackoverflow.com/a/25193580
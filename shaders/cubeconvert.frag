@@ -0,0 +1,72 @@
+#version 410
+
+uniform sampler2D equirect;
+uniform int face;
+uniform bool leftEye;
+uniform bool overUnder;
+uniform float texelStep; // one face texel in facePosition units
+
+in vec2 facePosition;
+
+out vec4 fragColor;
+
+const float PI = 3.14159265358979;
+
+// inverse of the GL cube map face selection rules
+vec3 faceDirection(vec2 p)
+{
+    if (face == 0)
+        return vec3(1.0, -p.y, -p.x);
+    else if (face == 1)
+        return vec3(-1.0, -p.y, p.x);
+    else if (face == 2)
+        return vec3(p.x, 1.0, p.y);
+    else if (face == 3)
+        return vec3(p.x, -1.0, -p.y);
+    else if (face == 4)
+        return vec3(p.x, -p.y, 1.0);
+    else
+        return vec3(-p.x, -p.y, -1.0);
+}
+
+// change in texCoord for an offset across the face, worked out from the mapping
+// since screen space derivatives jump at the seam
+vec2 texCoordGradient(vec3 d, vec3 offset)
+{
+    float len = length(d);
+    vec3 n = d / len;
+    vec3 dn = (offset - n * dot(n, offset)) / len;
+
+    // shrinks towards the poles, where a texel row covers less and less of the sphere
+    float horizontal = max(n.x * n.x + n.z * n.z, 1e-6);
+
+    return vec2((n.z * dn.x - n.x * dn.z) / horizontal / (2.0 * PI),
+                dn.y / sqrt(horizontal) / PI);
+}
+
+void main()
+{
+    vec3 d = faceDirection(facePosition);
+    vec3 direction = normalize(d);
+
+    // same mapping as the texture coordinates in sphere.obj
+    vec2 texCoord = vec2(fract(atan(direction.x, direction.z) / (2.0 * PI)),
+                         0.5 + asin(direction.y) / PI);
+
+    vec2 dx = texCoordGradient(d, faceDirection(facePosition + vec2(texelStep, 0.0)) - d);
+    vec2 dy = texCoordGradient(d, faceDirection(facePosition + vec2(0.0, texelStep)) - d);
+
+    if (overUnder) {
+        dx.t *= 0.5;
+        dy.t *= 0.5;
+
+        if (leftEye) {
+            texCoord.t = texCoord.t * 0.5 + 0.5;
+        }
+        else {
+            texCoord.t = texCoord.t * 0.5;
+        }
+    }
+
+    fragColor = textureGrad(equirect, texCoord, dx, dy);
+}
@@ -0,0 +1,12 @@
+#version 410
+
+out vec2 facePosition;
+
+void main()
+{
+    // one triangle covering the whole face, no vertex buffer needed
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    facePosition = position;
+
+    gl_Position = vec4(position, 0.0, 1.0);
+}
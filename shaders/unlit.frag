@@ -1,12 +1,29 @@
 #version 410
 
 uniform sampler2D diffuse;
+uniform samplerCube environment;
+uniform bool cubemap;
+uniform bool tonemap;
+uniform float exposure;
 
 in vec2 fragTexCoord;
+in vec3 fragDirection;
 
 out vec4 fragColor;
 
 void main()
 {
-    fragColor = texture2D(diffuse, fragTexCoord);
+    if (cubemap) {
+        fragColor = texture(environment, fragDirection);
+    }
+    else {
+        fragColor = texture2D(diffuse, fragTexCoord);
+    }
+
+    if (tonemap) {
+        // Reinhard on linear radiance, then back to gamma for the compositor
+        vec3 color = fragColor.rgb * exposure;
+        color = color / (1.0 + color);
+        fragColor.rgb = pow(color, vec3(1.0 / 2.2));
+    }
 }
@@ -2,14 +2,17 @@
 
 uniform bool leftEye;
 uniform bool overUnder;
+uniform bool flipped;
 uniform mat4 transform;
 in vec3 vertex;
 in vec2 texCoord;
 out vec2 fragTexCoord;
+out vec3 fragDirection;
 
 void main()
 {
     fragTexCoord = texCoord;
+    fragDirection = vertex;
 
     if (overUnder) {
         if (leftEye) {
@@ -20,5 +23,10 @@ void main()
         }
     }
 
+    // same as mirroring the whole image on both axes before upload
+    if (flipped) {
+        fragTexCoord = vec2(1.0) - fragTexCoord;
+    }
+
     gl_Position = transform * vec4(vertex, 1.0f);
 }
@@ -0,0 +1,170 @@
+#ifndef HDRFORMATS_H
+#define HDRFORMATS_H
+
+#include <QVector>
+#include <QIODevice>
+#include <QString>
+#include <QByteArray>
+#include <QRegExp>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+// decoded high dynamic range image, RGBA half floats ready for upload
+struct HdrImage
+{
+    HdrImage() : width(0), height(0) {}
+
+    bool isNull() const { return pixels.isEmpty(); }
+
+    int width, height;
+    QVector<quint16> pixels;
+};
+
+// no denormals, we only care about what a display can show
+inline quint16 floatToHalf(float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    quint16 sign = quint16((bits >> 16) & 0x8000);
+    int exponent = int((bits >> 23) & 0xff) - 127 + 15;
+    quint32 mantissa = bits & 0x7fffff;
+
+    if (exponent <= 0)
+        return sign;
+    if (exponent >= 31)
+        return quint16(sign | 0x7c00);
+
+    // rounding may carry into the exponent, which is what we want
+    return quint16(sign | ((exponent << 10) + ((mantissa + 0x1000) >> 13)));
+}
+
+// reads one scanline of RGBE pixels, handling both flat and new-style RLE data
+inline bool readRgbeScanline(QIODevice &file, int width, uchar *scanline)
+{
+    if (width < 8 || width > 0x7fff)
+        return file.read((char*)scanline, width * 4) == width * 4;
+
+    uchar rgbe[4];
+    if (file.read((char*)rgbe, 4) != 4)
+        return false;
+
+    if (rgbe[0] != 2 || rgbe[1] != 2 || (rgbe[2] & 0x80))
+    {
+        // not run length encoded
+        memcpy(scanline, rgbe, 4);
+        int rest = (width - 1) * 4;
+        return file.read((char*)scanline + 4, rest) == rest;
+    }
+
+    if (((rgbe[2] << 8) | rgbe[3]) != width)
+        return false;
+
+    QByteArray channel(width, 0);
+
+    // channels are stored one after the other
+    for (int c=0; c<4; c++)
+    {
+        int x = 0;
+        while (x < width)
+        {
+            uchar count;
+            if (!file.getChar((char*)&count))
+                return false;
+
+            if (count > 128)
+            {
+                count -= 128;
+                char value;
+                if (count > width - x || !file.getChar(&value))
+                    return false;
+                memset(channel.data() + x, value, count);
+            }
+            else
+            {
+                if (count == 0 || count > width - x ||
+                    file.read(channel.data() + x, count) != count)
+                    return false;
+            }
+            x += count;
+        }
+
+        for (x=0; x<width; x++)
+            scanline[x*4+c] = channel.at(x);
+    }
+
+    return true;
+}
+
+// Radiance RGBE (.hdr) reader, only supports the common -Y +X orientation
+inline HdrImage readHdr(QIODevice &inputFile, const QString &filename)
+{
+    HdrImage result;
+
+    QByteArray magic = inputFile.readLine().trimmed();
+    if (magic != "#?RADIANCE" && magic != "#?RGBE")
+    {
+        qWarning() << filename << "is not a Radiance file";
+        return result;
+    }
+
+    while (!inputFile.atEnd())
+    {
+        QByteArray line = inputFile.readLine().trimmed();
+        if (line.isEmpty())
+            break;
+
+        if (line.startsWith("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe")
+        {
+            qWarning() << "unsupported Radiance format" << line;
+            return result;
+        }
+    }
+
+    QRegExp resolution("-Y (\\d+) \\+X (\\d+)");
+    if (!resolution.exactMatch(QString::fromLatin1(inputFile.readLine().trimmed())))
+    {
+        qWarning() << "unsupported Radiance orientation in" << filename;
+        return result;
+    }
+
+    int height = resolution.cap(1).toInt();
+    int width = resolution.cap(2).toInt();
+    if (width <= 0 || height <= 0)
+        return result;
+
+    QVector<quint16> pixels(width * height * 4);
+    QVector<uchar> scanline(width * 4);
+
+    for (int y=0; y<height; y++)
+    {
+        if (!readRgbeScanline(inputFile, width, scanline.data()))
+        {
+            qWarning() << "truncated Radiance data in" << filename;
+            return result;
+        }
+
+        // flip both axes to match the QImage::mirrored(true, true) path
+        quint16 *out = pixels.data() + (height - 1 - y) * width * 4;
+        for (int x=0; x<width; x++)
+        {
+            const uchar *in = scanline.constData() + x * 4;
+            quint16 *texel = out + (width - 1 - x) * 4;
+
+            float scale = in[3] ? std::ldexp(1.0f, in[3] - (128 + 8)) : 0.0f;
+            texel[0] = floatToHalf(in[0] * scale);
+            texel[1] = floatToHalf(in[1] * scale);
+            texel[2] = floatToHalf(in[2] * scale);
+            texel[3] = 0x3c00; // 1.0
+        }
+    }
+
+    result.width = width;
+    result.height = height;
+    result.pixels = pixels;
+
+    return result;
+}
+
+#endif // HDRFORMATS_H
@@ -2,9 +2,13 @@
 #include <QApplication>
 #include <QSurfaceFormat>
 #include <QSettings>
+#include <QCommandLineParser>
+#include "startup.h"
 
 int main(int argc, char *argv[])
 {
+    startupTimer().start();
+
     QCoreApplication::setOrganizationName("Skeletonbrain");
     QCoreApplication::setOrganizationDomain("skeletonbrain.com");
     QCoreApplication::setApplicationName("QVRViewer");
@@ -20,8 +24,21 @@ int main(int argc, char *argv[])
     QSurfaceFormat::setDefaultFormat(glFormat);
 
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("OpenVR viewer for 360 panoramas");
+    parser.addHelpOption();
+    parser.addPositionalArgument("panorama", "Image or video to open on start up.");
+    parser.process(a);
+
     MainWindow w;
+
+    // kicked off before show() so decoding overlaps GL and OpenVR start up
+    if (!parser.positionalArguments().isEmpty())
+        w.loadPanorama(parser.positionalArguments().first());
+
     w.show();
+    startupMark("window shown");
 
     return a.exec();
 }
@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "vrview.h"
+#include "slideshow.h"
 
 #include <QVBoxLayout>
 #include <QSurfaceFormat>
@@ -8,6 +9,7 @@
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QOffscreenSurface>
+#include <QFileInfo>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -22,6 +24,14 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->rightLayout->addWidget(vr);
 
     connect(vr, &VRView::statusMessage, this, &MainWindow::showStatus);
+
+    QSettings settings;
+    slideshow = new Slideshow(vr, this);
+    slideshow->setInterval(settings.value("Slideshow/Interval", 10000).toInt());
+
+    connect(slideshow, &Slideshow::statusMessage, this, &MainWindow::showStatus);
+    connect(slideshow, &Slideshow::stopped, this, &MainWindow::stopSlideshow);
+    connect(vr, &VRView::panoramaRequested, this, &MainWindow::stopSlideshow);
 }
 
 MainWindow::~MainWindow()
@@ -30,6 +40,11 @@ MainWindow::~MainWindow()
     delete vr;
 }
 
+void MainWindow::loadPanorama(const QString &fileName)
+{
+    vr->loadPanorama(fileName);
+}
+
 void MainWindow::showFramerate(float fps)
 {
     ui->fpsLabel->setText(tr("%1 FPS").arg(fps));
@@ -40,13 +55,21 @@ void MainWindow::showStatus(const QString &message)
     ui->statusBar->showMessage(message);
 }
 
+void MainWindow::stopSlideshow()
+{
+    // opening an image by hand takes over the view, so the slideshow gives way. Also keeps
+    // the action in sync when the slideshow stops itself, e.g. when no image would decode
+    ui->action_Slideshow->setChecked(false);
+}
+
 void MainWindow::on_action_Load_Panorama_triggered()
 {
     QSettings settings;
 
     QFileDialog fileDialog;
     fileDialog.setFileMode(QFileDialog::ExistingFile);
-    fileDialog.setNameFilter("Images (*.png *.jpg)");
+    fileDialog.setNameFilters(QStringList() << "Images (*.png *.jpg *.hdr)"
+                              << "Videos (*.mp4 *.mkv *.mov *.webm)");
 
     if (settings.value("Load/PanoramaDir").isValid())
         fileDialog.setDirectory(settings.value("Load/PanoramaDir").toString());
@@ -59,3 +82,54 @@ void MainWindow::on_action_Load_Panorama_triggered()
         vr->loadPanorama(fileDialog.selectedFiles().first());
     }
 }
+
+void MainWindow::on_action_Load_Playlist_triggered()
+{
+    QSettings settings;
+
+    QFileDialog fileDialog;
+    fileDialog.setFileMode(QFileDialog::ExistingFile);
+    fileDialog.setNameFilter("Playlists (*.m3u *.txt)");
+
+    if (settings.value("Load/PlaylistDir").isValid())
+        fileDialog.setDirectory(settings.value("Load/PlaylistDir").toString());
+    else if (settings.value("Load/PanoramaDir").isValid())
+        fileDialog.setDirectory(settings.value("Load/PanoramaDir").toString());
+
+    if (fileDialog.exec())
+    {
+        settings.setValue("Load/PlaylistDir", fileDialog.directory().path());
+
+        if (!slideshow->loadPlaylist(fileDialog.selectedFiles().first()))
+        {
+            showStatus(tr("No images found in playlist"));
+            return;
+        }
+
+        // restart so the new list takes effect straight away
+        ui->action_Slideshow->setChecked(false);
+        ui->action_Slideshow->setChecked(true);
+    }
+}
+
+void MainWindow::on_action_Slideshow_toggled(bool enabled)
+{
+    if (!enabled)
+    {
+        slideshow->stop();
+        return;
+    }
+
+    // without a playlist, run through the directory of the current image
+    QFileInfo current(vr->currentImage());
+    if (!slideshow->hasPlaylist() && current.exists())
+        slideshow->loadDirectory(current.dir().path());
+
+    slideshow->start();
+
+    if (!slideshow->isRunning())
+    {
+        showStatus(tr("Load a panorama or playlist to start a slideshow"));
+        ui->action_Slideshow->setChecked(false);
+    }
+}
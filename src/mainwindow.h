@@ -8,6 +8,7 @@ class MainWindow;
 }
 
 class VRView;
+class Slideshow;
 
 class MainWindow : public QMainWindow
 {
@@ -17,16 +18,22 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+    void loadPanorama(const QString &fileName);
+
 protected slots:
     void showFramerate(float fps);
     void showStatus(const QString &message);
+    void stopSlideshow();
 
 private slots:
     void on_action_Load_Panorama_triggered();
+    void on_action_Load_Playlist_triggered();
+    void on_action_Slideshow_toggled(bool enabled);
 
 private:
     Ui::MainWindow *ui;
     VRView *vr;
+    Slideshow *slideshow;
 };
 
 #endif // MAINWINDOW_H
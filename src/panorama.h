@@ -0,0 +1,87 @@
+#ifndef PANORAMA_H
+#define PANORAMA_H
+
+#include <QImage>
+#include <QFile>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "hdrformats.h"
+
+// a decoded panorama in the layout we upload, safe to produce on worker threads
+struct Panorama
+{
+    Panorama() : readTime(0), decodeTime(0) {}
+
+    bool isNull() const { return image.isNull() && hdr.isNull(); }
+    bool isHdr() const { return !hdr.isNull(); }
+
+    int width() const { return isHdr() ? hdr.width : image.width(); }
+    int height() const { return isHdr() ? hdr.height : image.height(); }
+    int bytesPerLine() const { return isHdr() ? hdr.width * 4 * int(sizeof(quint16)) : image.bytesPerLine(); }
+
+    const void *scanLine(int y) const
+    {
+        if (isHdr())
+            return hdr.pixels.constData() + y * hdr.width * 4;
+        return image.constScanLine(y);
+    }
+
+    QString fileName;
+    QImage image;
+    HdrImage hdr;
+
+    // milliseconds spent reading the file and decoding it
+    qint64 readTime, decodeTime;
+};
+
+inline QStringList panoramaFilters()
+{
+    return QStringList() << "*.jpg" << "*.png" << "*.hdr";
+}
+
+inline bool isHdrFile(const QString &fileName)
+{
+    return QFileInfo(fileName).suffix().toLower() == "hdr";
+}
+
+inline Panorama decodePanorama(const QString &fileName)
+{
+    Panorama result;
+    result.fileName = fileName;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // read everything up front so I/O and decode costs can be told apart
+    QFile inputFile(fileName);
+    if (!inputFile.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "unable to open" << fileName;
+        return result;
+    }
+
+    QByteArray data = inputFile.readAll();
+    result.readTime = timer.restart();
+
+    if (isHdrFile(fileName))
+    {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        result.hdr = readHdr(buffer, fileName);
+    }
+    else
+    {
+        // flipped to match the sphere's texture coordinates
+        result.image = QImage::fromData(data).mirrored(true, true)
+                .convertToFormat(QImage::Format_RGBA8888);
+    }
+
+    result.decodeTime = timer.elapsed();
+
+    return result;
+}
+
+#endif // PANORAMA_H
@@ -0,0 +1,296 @@
+#include "slideshow.h"
+#include "vrview.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <QtMath>
+
+// extra time on top of twice the expected cost before a deadline
+#define PREFETCH_MARGIN 1000
+
+// how often to retry staging while the view is busy with another image
+#define STAGE_RETRY 50
+
+Slideshow::Slideshow(VRView *view, QObject *parent) : QObject(parent),
+    m_view(view), m_playlist(false), m_index(0), m_interval(10000), m_running(false),
+    m_deadline(0), m_decodeStart(-1), m_readDone(-1), m_decodeDone(-1), m_uploadDone(-1),
+    m_deadlinePassed(false), m_expectedCost(0)
+{
+    m_decodeTimer.setSingleShot(true);
+    m_deadlineTimer.setSingleShot(true);
+    m_deadlineTimer.setTimerType(Qt::PreciseTimer);
+    m_stageTimer.setSingleShot(true);
+
+    connect(&m_decodeTimer, &QTimer::timeout, this, &Slideshow::startDecode);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, &Slideshow::deadlineReached);
+    connect(&m_stageTimer, &QTimer::timeout, this, &Slideshow::stagePanorama);
+    connect(&m_decodeWatcher, &QFutureWatcher<Panorama>::finished, this, &Slideshow::panoramaDecoded);
+    // emitted from inside paintGL, queued so showPrepared doesn't call doneCurrent halfway through a frame
+    connect(m_view, &VRView::panoramaPrepared, this, &Slideshow::panoramaPrepared, Qt::QueuedConnection);
+}
+
+bool Slideshow::loadPlaylist(const QString &fileName)
+{
+    QFile inputFile(fileName);
+    if (!inputFile.open(QIODevice::ReadOnly))
+        return false;
+
+    // one image per line, m3u style comments, paths relative to the playlist
+    QDir dir = QFileInfo(fileName).dir();
+    QStringList files;
+
+    QTextStream in(&inputFile);
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith("#"))
+            continue;
+
+        QFileInfo info(dir, line);
+        if (info.exists())
+            files.append(info.absoluteFilePath());
+        else
+            qWarning() << "playlist entry not found" << line;
+    }
+
+    if (files.isEmpty())
+        return false;
+
+    m_files = files;
+    m_playlist = true;
+    m_index = 0;
+    return true;
+}
+
+bool Slideshow::loadDirectory(const QString &path)
+{
+    QStringList files;
+    foreach (const QFileInfo &info, QDir(path).entryInfoList(panoramaFilters(), QDir::NoDotAndDotDot|QDir::Files))
+        files.append(info.absoluteFilePath());
+
+    if (files.isEmpty())
+        return false;
+
+    m_files = files;
+    m_playlist = false;
+    m_index = 0;
+    return true;
+}
+
+bool Slideshow::hasPlaylist() const
+{
+    return m_playlist;
+}
+
+void Slideshow::setInterval(int msec)
+{
+    // any shorter and every deadline is already due, so slides decode back to back and all miss
+    int minimum = PREFETCH_MARGIN + qCeil(m_view->frameTime());
+    if (msec < minimum)
+    {
+        qWarning() << "slideshow interval" << msec << "ms is too short, using" << minimum << "ms";
+        msec = minimum;
+    }
+
+    m_interval = msec;
+}
+
+bool Slideshow::isRunning() const
+{
+    return m_running;
+}
+
+void Slideshow::start()
+{
+    if (m_files.isEmpty())
+        return;
+
+    // carry on from whatever is on screen if it's part of the list
+    int current = m_files.indexOf(m_view->currentImage());
+    m_index = (current + 1) % m_files.length();
+
+    m_running = true;
+    m_stats = Stats();
+    m_clock.start();
+    m_deadline = m_interval;
+
+    emit statusMessage(tr("Slideshow started, %1 images every %2s")
+                       .arg(m_files.length()).arg(m_interval / 1000.0));
+
+    scheduleNext();
+}
+
+void Slideshow::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    m_decodeTimer.stop();
+    m_deadlineTimer.stop();
+    m_stageTimer.stop();
+    m_decoded = Panorama();
+
+    // otherwise the next slide keeps uploading and holds on to its textures
+    if (!m_files.isEmpty())
+        m_view->cancelPrepared(m_files.at(m_index));
+
+    qDebug() << "slideshow stopped," << m_stats.shown << "shown," << m_stats.missed << "missed"
+             << "(io" << m_stats.missedIO << "decode" << m_stats.missedDecode
+             << "upload" << m_stats.missedUpload << "), worst" << m_stats.worstLateness << "ms late";
+
+    emit statusMessage(tr("Slideshow stopped, %1 of %2 slides missed their deadline")
+                       .arg(m_stats.missed).arg(m_stats.shown));
+    emit stopped();
+}
+
+void Slideshow::scheduleNext()
+{
+    m_decodeStart = m_readDone = m_decodeDone = m_uploadDone = -1;
+    m_deadlinePassed = false;
+
+    qint64 now = m_clock.elapsed();
+    qint64 startAt = m_deadline - 2 * m_expectedCost - PREFETCH_MARGIN;
+
+    if (m_expectedCost > m_interval)
+        qWarning() << "slides take" << m_expectedCost << "ms to prepare, longer than the interval";
+
+    // the deadline is never more than an interval ahead, so both fit QTimer's int
+    m_decodeTimer.start(int(qBound<qint64>(0, startAt - now, m_interval)));
+    m_deadlineTimer.start(int(qBound<qint64>(0, m_deadline - now, m_interval)));
+}
+
+void Slideshow::startDecode()
+{
+    if (!m_running)
+        return;
+
+    m_decodeStart = m_clock.elapsed();
+    m_decodeWatcher.setFuture(QtConcurrent::run(decodePanorama, m_files.at(m_index)));
+}
+
+void Slideshow::panoramaDecoded()
+{
+    Panorama panorama = m_decodeWatcher.result();
+
+    if (!m_running || panorama.fileName != m_files.at(m_index))
+        return;
+
+    if (panorama.isNull())
+    {
+        // drop it and try the next one against the same deadline
+        qWarning() << "skipping" << panorama.fileName;
+        m_files.removeAt(m_index);
+        if (m_files.isEmpty())
+        {
+            stop();
+            return;
+        }
+        m_index %= m_files.length();
+        startDecode();
+        return;
+    }
+
+    m_decodeDone = m_clock.elapsed();
+    m_readDone = m_decodeStart + panorama.readTime;
+
+    m_decoded = panorama;
+    stagePanorama();
+}
+
+void Slideshow::stagePanorama()
+{
+    if (!m_running || m_decoded.isNull())
+        return;
+
+    // only happens when started while an opened image is still loading, counts as upload time
+    if (!m_view->preparePanorama(m_decoded))
+    {
+        m_stageTimer.start(STAGE_RETRY);
+        return;
+    }
+
+    m_decoded = Panorama();
+}
+
+void Slideshow::panoramaPrepared(const QString &fileName, qint64 uploadTime)
+{
+    if (!m_running || fileName != m_files.at(m_index))
+        return;
+
+    m_uploadDone = m_clock.elapsed();
+
+    // lean towards the worst case so one slow image pushes the next prefetch earlier
+    qint64 cost = m_uploadDone - m_decodeStart;
+    m_expectedCost = qMax(cost, (3 * m_expectedCost + cost) / 4);
+
+    qDebug() << "slide ready" << m_deadline - m_uploadDone << "ms early, upload" << uploadTime << "ms";
+
+    if (m_deadlinePassed)
+        present();
+}
+
+void Slideshow::deadlineReached()
+{
+    m_deadlinePassed = true;
+
+    if (m_uploadDone >= 0)
+        present();
+    else
+        qDebug() << "slide not ready at deadline";
+}
+
+void Slideshow::present()
+{
+    if (!m_view->showPrepared(m_files.at(m_index)))
+    {
+        qWarning() << "prepared slide was replaced, reloading";
+        m_uploadDone = -1;
+        startDecode();
+        return;
+    }
+
+    qint64 now = m_clock.elapsed();
+    qint64 lateness = now - m_deadline;
+
+    m_stats.shown++;
+    m_stats.worstLateness = qMax(m_stats.worstLateness, lateness);
+
+    // anything within a frame lands on the same compositor frame
+    if (lateness > m_view->frameTime())
+    {
+        m_stats.missed++;
+
+        QString reason;
+        if (m_readDone > m_deadline)
+        {
+            m_stats.missedIO++;
+            reason = "io";
+        }
+        else if (m_decodeDone > m_deadline)
+        {
+            m_stats.missedDecode++;
+            reason = "decode";
+        }
+        else
+        {
+            m_stats.missedUpload++;
+            reason = "upload";
+        }
+
+        qWarning() << "missed deadline by" << lateness << "ms, waiting on" << reason;
+        emit statusMessage(tr("Slide %1 late by %2 ms (%3)")
+                           .arg(QFileInfo(m_files.at(m_index)).fileName()).arg(lateness).arg(reason));
+    }
+
+    m_index = (m_index + 1) % m_files.length();
+
+    // keep the cadence unless we've fallen a whole interval behind
+    m_deadline += m_interval;
+    if (m_deadline <= now)
+        m_deadline = now + m_interval;
+
+    scheduleNext();
+}
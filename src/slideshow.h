@@ -0,0 +1,85 @@
+#ifndef SLIDESHOW_H
+#define SLIDESHOW_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include "panorama.h"
+
+class VRView;
+
+// Advances through a playlist on a fixed interval. Each slide is read, decoded
+// and uploaded ahead of its deadline so the switch itself is just a texture swap.
+class Slideshow : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Slideshow(VRView *view, QObject *parent = 0);
+
+    bool loadPlaylist(const QString &fileName);
+    bool loadDirectory(const QString &path);
+    bool hasPlaylist() const;
+
+    void setInterval(int msec);
+    bool isRunning() const;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void statusMessage(const QString&);
+    void stopped();
+
+private slots:
+    void startDecode();
+    void panoramaDecoded();
+    void stagePanorama();
+    void panoramaPrepared(const QString &fileName, qint64 uploadTime);
+    void deadlineReached();
+
+private:
+    // slides that went up more than a frame after their deadline, by the stage that ran late
+    struct Stats
+    {
+        Stats() : shown(0), missed(0), missedIO(0), missedDecode(0), missedUpload(0), worstLateness(0) {}
+
+        int shown;
+        int missed;
+        int missedIO, missedDecode, missedUpload;
+        qint64 worstLateness;
+    };
+
+    void scheduleNext();
+    void present();
+
+    VRView *m_view;
+    QStringList m_files;
+    bool m_playlist;
+    int m_index;
+    int m_interval;
+    bool m_running;
+
+    QElapsedTimer m_clock;
+    qint64 m_deadline;
+    QTimer m_decodeTimer;
+    QTimer m_deadlineTimer;
+    QTimer m_stageTimer;
+    QFutureWatcher<Panorama> m_decodeWatcher;
+
+    // decoded but waiting for the view to finish loading something the user opened
+    Panorama m_decoded;
+
+    // clock times each stage of the upcoming slide finished, -1 while pending
+    qint64 m_decodeStart, m_readDone, m_decodeDone, m_uploadDone;
+    bool m_deadlinePassed;
+
+    // running estimate of read + decode + upload, used to pick when to start
+    qint64 m_expectedCost;
+
+    Stats m_stats;
+};
+
+#endif // SLIDESHOW_H
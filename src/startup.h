@@ -0,0 +1,21 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+// started first thing in main(), everything up to the first frame is measured against it
+inline QElapsedTimer &startupTimer()
+{
+    static QElapsedTimer timer;
+    return timer;
+}
+
+inline qint64 startupMark(const char *stage)
+{
+    qint64 elapsed = startupTimer().elapsed();
+    qDebug() << "startup:" << stage << "at" << elapsed << "ms";
+    return elapsed;
+}
+
+#endif // STARTUP_H
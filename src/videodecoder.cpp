@@ -0,0 +1,268 @@
+#include "videodecoder.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+// each 4k over/under frame is 64MB, so keep the pool small
+#define VIDEO_FRAME_POOL 4
+
+VideoDecoder::VideoDecoder(QObject *parent) : QThread(parent),
+    m_format(0), m_codec(0), m_scaler(0), m_stream(-1),
+    m_width(0), m_height(0), m_frameDuration(33), m_startTime(0),
+    m_loopOffset(0), m_lastPts(0), m_stop(0), m_dropped(0)
+{
+}
+
+VideoDecoder::~VideoDecoder()
+{
+    close();
+}
+
+bool VideoDecoder::open(const QString &fileName)
+{
+    if (avformat_open_input(&m_format, fileName.toUtf8().constData(), NULL, NULL) < 0)
+    {
+        qWarning() << "unable to open video" << fileName;
+        return false;
+    }
+
+    if (avformat_find_stream_info(m_format, NULL) < 0)
+    {
+        qWarning() << "no stream info in" << fileName;
+        return false;
+    }
+
+    m_stream = av_find_best_stream(m_format, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (m_stream < 0)
+    {
+        qWarning() << "no video stream in" << fileName;
+        return false;
+    }
+
+    AVStream *stream = m_format->streams[m_stream];
+
+    // only plain software decoders, no hwaccel setup, so it behaves the same everywhere
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec)
+    {
+        qWarning() << "no decoder for" << fileName;
+        return false;
+    }
+
+    m_codec = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(m_codec, stream->codecpar);
+    m_codec->thread_count = QThread::idealThreadCount();
+    m_codec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    if (avcodec_open2(m_codec, codec, NULL) < 0)
+    {
+        qWarning() << "unable to open decoder for" << fileName;
+        return false;
+    }
+
+    m_width = m_codec->width;
+    m_height = m_codec->height;
+
+    AVRational rate = av_guess_frame_rate(m_format, stream, NULL);
+    if (rate.num > 0 && rate.den > 0)
+        m_frameDuration = qMax<qint64>(1, 1000 * rate.den / rate.num);
+
+    if (stream->start_time != AV_NOPTS_VALUE)
+        m_startTime = av_rescale_q(stream->start_time, stream->time_base, AVRational{1, 1000});
+
+    // frames only become free once the renderer attaches memory to them
+    m_frames.resize(VIDEO_FRAME_POOL);
+
+    qDebug() << "opened video" << m_width << "x" << m_height << "at" << m_frameDuration << "ms per frame,"
+             << m_codec->thread_count << "decode threads";
+
+    return true;
+}
+
+void VideoDecoder::close()
+{
+    m_stop = 1;
+
+    m_mutex.lock();
+    m_frameFreed.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+
+    sws_freeContext(m_scaler);
+    m_scaler = 0;
+    avcodec_free_context(&m_codec);
+    avformat_close_input(&m_format);
+}
+
+int VideoDecoder::width() const
+{
+    return m_width;
+}
+
+int VideoDecoder::height() const
+{
+    return m_height;
+}
+
+qint64 VideoDecoder::frameDuration() const
+{
+    return m_frameDuration;
+}
+
+int VideoDecoder::frameCount() const
+{
+    return m_frames.size();
+}
+
+qint64 VideoDecoder::nextFrameTime()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_ready.isEmpty())
+        return -1;
+
+    return m_frames.at(m_ready.head()).pts;
+}
+
+int VideoDecoder::acquireFrame(qint64 time)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // take the newest frame that is due, anything older than it is dropped
+    int result = -1;
+    while (!m_ready.isEmpty() && m_frames.at(m_ready.head()).pts <= time)
+    {
+        if (result >= 0)
+        {
+            m_free.enqueue(result);
+            m_dropped++;
+            m_frameFreed.wakeOne();
+        }
+        result = m_ready.dequeue();
+    }
+
+    return result;
+}
+
+const VideoFrame &VideoDecoder::frame(int index) const
+{
+    return m_frames.at(index);
+}
+
+void VideoDecoder::attachFrame(int index, uchar *pixels)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_frames[index].pixels = pixels;
+    m_free.enqueue(index);
+    m_frameFreed.wakeOne();
+}
+
+int VideoDecoder::droppedFrames()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+void VideoDecoder::run()
+{
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *decoded = av_frame_alloc();
+    bool decodedSinceLoop = false;
+
+    while (!m_stop)
+    {
+        int result = av_read_frame(m_format, packet);
+
+        if (result == AVERROR_EOF)
+        {
+            // drain what the decoder still holds, then loop the video
+            avcodec_send_packet(m_codec, NULL);
+            decodedSinceLoop |= receiveFrames(decoded);
+
+            if (!decodedSinceLoop)
+                break;
+
+            m_loopOffset = m_lastPts + m_frameDuration;
+            decodedSinceLoop = false;
+
+            av_seek_frame(m_format, m_stream, 0, AVSEEK_FLAG_BACKWARD);
+            avcodec_flush_buffers(m_codec);
+            continue;
+        }
+        else if (result < 0)
+        {
+            qWarning() << "video read failed" << result;
+            break;
+        }
+
+        if (packet->stream_index == m_stream && avcodec_send_packet(m_codec, packet) >= 0)
+            decodedSinceLoop |= receiveFrames(decoded);
+
+        av_packet_unref(packet);
+    }
+
+    av_frame_free(&decoded);
+    av_packet_free(&packet);
+}
+
+bool VideoDecoder::receiveFrames(AVFrame *decoded)
+{
+    AVStream *stream = m_format->streams[m_stream];
+    bool received = false;
+
+    while (!m_stop && avcodec_receive_frame(m_codec, decoded) == 0)
+    {
+        int index = nextFreeFrame();
+        if (index < 0)
+            break;
+
+        VideoFrame &frame = m_frames[index];
+
+        m_scaler = sws_getCachedContext(m_scaler, decoded->width, decoded->height, (AVPixelFormat)decoded->format,
+                                        m_width, m_height, AV_PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL);
+
+        uint8_t *data[4] = { frame.pixels, 0, 0, 0 };
+        int stride[4] = { m_width * 4, 0, 0, 0 };
+        sws_scale(m_scaler, decoded->data, decoded->linesize, 0, decoded->height, data, stride);
+
+        if (decoded->best_effort_timestamp == AV_NOPTS_VALUE)
+        {
+            frame.pts = m_lastPts + m_frameDuration;
+        }
+        else
+        {
+            qint64 pts = av_rescale_q(decoded->best_effort_timestamp, stream->time_base, AVRational{1, 1000});
+            frame.pts = pts - m_startTime + m_loopOffset;
+        }
+        m_lastPts = frame.pts;
+        received = true;
+
+        av_frame_unref(decoded);
+
+        QMutexLocker locker(&m_mutex);
+        m_ready.enqueue(index);
+    }
+
+    return received;
+}
+
+int VideoDecoder::nextFreeFrame()
+{
+    QMutexLocker locker(&m_mutex);
+
+    // the pool is the only backpressure, we sleep here when far enough ahead
+    while (m_free.isEmpty() && !m_stop)
+        m_frameFreed.wait(&m_mutex);
+
+    if (m_stop)
+        return -1;
+
+    return m_free.dequeue();
+}
@@ -0,0 +1,84 @@
+#ifndef VIDEODECODER_H
+#define VIDEODECODER_H
+
+#include <QThread>
+#include <QVector>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QStringList>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVFrame;
+struct SwsContext;
+
+// an RGBA frame in the decoder's pool, the pixels live in a pixel buffer the renderer has mapped
+struct VideoFrame
+{
+    VideoFrame() : pts(-1), pixels(0) {}
+
+    qint64 pts; // presentation time in ms, keeps increasing across loops
+    uchar *pixels;
+};
+
+inline QStringList videoFilters()
+{
+    return QStringList() << "*.mp4" << "*.mkv" << "*.mov" << "*.webm";
+}
+
+// Software decodes a video on its own thread (plus libavcodec's frame threads)
+// straight into a small pool of mapped pixel buffers. The renderer attaches each
+// buffer's memory, takes the newest frame that is due, unmaps it for the upload
+// and attaches it again once remapped; older due frames are dropped.
+class VideoDecoder : public QThread
+{
+    Q_OBJECT
+public:
+    explicit VideoDecoder(QObject *parent = 0);
+    ~VideoDecoder();
+
+    bool open(const QString &fileName);
+    void close();
+
+    int width() const;
+    int height() const;
+    qint64 frameDuration() const;
+    int frameCount() const;
+
+    qint64 nextFrameTime();
+    int acquireFrame(qint64 time);
+    const VideoFrame &frame(int index) const;
+    void attachFrame(int index, uchar *pixels);
+
+    int droppedFrames();
+
+protected:
+    void run();
+
+private:
+    bool receiveFrames(AVFrame *decoded);
+    int nextFreeFrame();
+
+    AVFormatContext *m_format;
+    AVCodecContext *m_codec;
+    SwsContext *m_scaler;
+    int m_stream;
+
+    int m_width, m_height;
+    qint64 m_frameDuration;
+    qint64 m_startTime;
+    qint64 m_loopOffset;
+    qint64 m_lastPts;
+
+    QVector<VideoFrame> m_frames;
+    QQueue<int> m_free;
+    QQueue<int> m_ready;
+    QMutex m_mutex;
+    QWaitCondition m_frameFreed;
+    QAtomicInt m_stop;
+    int m_dropped;
+};
+
+#endif // VIDEODECODER_H
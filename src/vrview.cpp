@@ -6,15 +6,27 @@
 #include <QDir>
 #include <QKeyEvent>
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QtMath>
 #include "modelFormats.h"
+#include "videodecoder.h"
+#include "startup.h"
 
 #define NEAR_CLIP 0.1f
 #define FAR_CLIP 10000.0f
+#define UPLOAD_BYTES_PER_FRAME (8 * 1024 * 1024)
+
+// frames of GPU timing averaged before logging it, once per sampling path
+#define SAMPLE_LOG_FRAMES 120
 
 VRView::VRView(QWidget *parent) : QOpenGLWidget(parent),
-    m_hmd(0), m_texture(0), m_vertCount(0),
+    m_hmd(0), m_vertCount(0), m_glReady(false), m_firstFrame(true), m_startupLoad(false), m_startupShown(false), m_nextRow(0), m_nextStep(0), m_uploadTime(0), m_showNext(false),
+    m_pendingMode(None), m_exposure(0.0f),
+    m_video(0), m_videoStart(0), m_videoStartVsync(0), m_lastVideoPts(-1), m_videoLateFrames(0),
+    m_cubemapMode(true), m_pixelsPerDegree(0.0f), m_frameTime(1000.0f / 60.0f),
     m_eyeWidth(0), m_eyeHeight(0), m_leftBuffer(0), m_rightBuffer(0),
-    m_frames(0), m_mode(None)
+    m_frames(0), m_sampleQueryIndex(0), m_sampleTime(0), m_sampleCount(0)
 {
     memset(m_inputNext, 0, sizeof(m_inputNext));
     memset(m_inputNext, 0, sizeof(m_inputPrev));
@@ -28,6 +40,12 @@ VRView::VRView(QWidget *parent) : QOpenGLWidget(parent),
     connect(fpsTimer, &QTimer::timeout, this, &VRView::updateFramerate);
     fpsTimer->start(1000);
 
+    m_decodeWatcher = new QFutureWatcher<Panorama>(this);
+    connect(m_decodeWatcher, &QFutureWatcher<Panorama>::finished, this, &VRView::panoramaDecoded);
+
+    // nothing GL about parsing the mesh, so get it going before there is a context
+    m_mesh = QtConcurrent::run(readObj, QString(":/models/sphere.obj"));
+
     grabKeyboard();
 }
 
@@ -42,30 +60,224 @@ void VRView::loadPanorama(const QString &fileName, VRMode mode)
 
     if (info.exists())
     {
+        emit panoramaRequested(fileName);
+
+        // only loads from before initializeGL count towards start up
+        m_startupLoad = !m_glReady;
+
+        // anything still staged is superseded, so stop uploading it
+        if (m_glReady)
+        {
+            makeCurrent();
+            releaseStaged();
+            doneCurrent();
+        }
+
+        if (videoFilters().contains("*." + info.suffix().toLower()))
+        {
+            m_pendingImage.clear();
+
+            if (!m_glReady)
+            {
+                m_startupVideo = fileName;
+                m_pendingMode = mode;
+                return;
+            }
+
+            makeCurrent();
+            startVideo(fileName, mode);
+            doneCurrent();
+            return;
+        }
+
+        // before initializeGL there is nothing to upload to yet, so decode in the background
+        if (isHdrFile(fileName) || !m_glReady)
+        {
+            decodePanoramaAsync(fileName, mode);
+            return;
+        }
+
         qDebug() << "loading" << fileName;
-        delete m_texture;
-        m_texture = new QOpenGLTexture(QImage(fileName).mirrored(true, true));
-        m_texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
-        m_texture->setMagnificationFilter(QOpenGLTexture::Linear);
-        qDebug() << "loaded texture" << m_texture->width() << "x" << m_texture->height();
-        emit statusMessage(tr("Loaded %1 (%2x%3)").arg(info.fileName())
-                           .arg(m_texture->width()).arg(m_texture->height()));
-        m_mode = mode;
-
-        m_currentImage = fileName;
+        m_pendingImage.clear();
+
+        Panorama panorama = decodePanorama(fileName);
+        if (panorama.isNull())
+        {
+            emit statusMessage(tr("Unable to load %1").arg(info.fileName()));
+            return;
+        }
+
+        makeCurrent();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        Textures textures = createTextures(panorama, mode);
+        uploadRows(textures, panorama, 0, panorama.height());
+
+        int step = 0;
+        while (!finishStep(textures, step))
+            step++;
+
+        qDebug() << "loaded texture" << panorama.width() << "x" << panorama.height()
+                 << "read" << panorama.readTime << "ms decode" << panorama.decodeTime
+                 << "ms upload" << timer.elapsed() << "ms";
+
+        showTextures(textures);
+        doneCurrent();
+    }
+}
+
+void VRView::decodePanoramaAsync(const QString &fileName, VRMode mode)
+{
+    // decode off the render thread, the upload is then spread over frames
+    qDebug() << "decoding" << fileName;
+    m_pendingImage = fileName;
+    m_pendingMode = mode;
+    m_decodeWatcher->setFuture(QtConcurrent::run(decodePanorama, fileName));
+    emit statusMessage(tr("Decoding %1...").arg(QFileInfo(fileName).fileName()));
+}
+
+void VRView::panoramaDecoded()
+{
+    Panorama panorama = m_decodeWatcher->result();
+
+    // a newer image was requested while this one was decoding
+    if (panorama.fileName != m_pendingImage)
+        return;
+
+    m_pendingImage.clear();
+
+    if (panorama.isNull())
+    {
+        m_startupLoad = false;
+        emit statusMessage(tr("Unable to load %1").arg(QFileInfo(panorama.fileName).fileName()));
+
+        if (m_glReady)
+        {
+            makeCurrent();
+            ensurePlaceholder();
+            doneCurrent();
+        }
+        return;
+    }
+
+    qDebug() << "decoded" << panorama.width() << "x" << panorama.height()
+             << "read" << panorama.readTime << "ms decode" << panorama.decodeTime << "ms";
+
+    if (!m_glReady)
+    {
+        startupMark("panorama decoded");
+        m_startupPanorama = panorama;
+        return;
     }
+
+    makeCurrent();
+    stagePanorama(panorama, m_pendingMode);
+    doneCurrent();
+    m_showNext = true;
+}
+
+bool VRView::preparePanorama(const Panorama &panorama, VRMode mode)
+{
+    // there is only the one staging slot, and what the user opened goes first
+    if (m_showNext || !m_pendingImage.isEmpty())
+        return false;
+
+    makeCurrent();
+    stagePanorama(panorama, mode);
+    doneCurrent();
+    return true;
+}
+
+void VRView::stagePanorama(const Panorama &panorama, VRMode mode)
+{
+    releaseTextures(m_next);
+    m_next = createTextures(panorama, mode);
+
+    m_nextPanorama = panorama;
+    m_nextRow = 0;
+    m_nextStep = 0;
+    m_uploadTime = 0;
+    m_showNext = false;
+}
+
+void VRView::releaseStaged()
+{
+    releaseTextures(m_next);
+    m_nextPanorama = Panorama();
+    m_showNext = false;
+}
+
+void VRView::cancelPrepared(const QString &fileName)
+{
+    // only a panorama staged through preparePanorama, never one the user opened
+    if (m_showNext || m_next.fileName.isEmpty() || m_next.fileName != fileName)
+        return;
+
+    makeCurrent();
+    releaseStaged();
+    doneCurrent();
+}
+
+void VRView::ensurePlaceholder()
+{
+    if (m_current.texture || m_current.cubemap[0])
+        return;
+
+    m_current.texture = new QOpenGLTexture(QImage(":/textures/uvmap.png"));
+}
+
+bool VRView::showPrepared(const QString &fileName)
+{
+    // still uploading, or something else has been staged since
+    if (!m_nextPanorama.isNull() || m_next.fileName != fileName)
+        return false;
+
+    makeCurrent();
+    showTextures(m_next);
+    doneCurrent();
+
+    m_next = Textures();
+    return true;
+}
+
+QString VRView::currentImage() const
+{
+    return m_current.fileName;
+}
+
+float VRView::frameTime() const
+{
+    return m_frameTime;
+}
+
+void VRView::adjustExposure(float stops)
+{
+    m_exposure += stops;
+    emit statusMessage(tr("Exposure %1 EV").arg(m_exposure));
+}
+
+void VRView::setCubemapMode(bool enabled)
+{
+    m_cubemapMode = enabled;
+    emit statusMessage(enabled ? tr("Cube map rendering") : tr("Equirectangular rendering"));
+
+    // the source texture is dropped after conversion, so decode it again. Video is never
+    // converted, and reloading would only restart it. Not a manual open, so no
+    // panoramaRequested and a running slideshow carries on
+    if (!m_current.fileName.isEmpty() && !m_video)
+        decodePanoramaAsync(m_current.fileName, m_current.mode);
 }
 
 void VRView::loadImageRelative(int offset)
 {
-    QFileInfo info(m_currentImage);
+    QFileInfo info(m_current.fileName);
 
     if (info.exists())
     {
         QDir dir = info.dir().path();
-        QStringList filters;
-        filters << "*.jpg" << "*.png";
-        QFileInfoList files = dir.entryInfoList(filters, QDir::NoDotAndDotDot|QDir::Files);
+        QFileInfoList files = dir.entryInfoList(panoramaFilters() + videoFilters(), QDir::NoDotAndDotDot|QDir::Files);
 
         int index = files.indexOf(info);
 
@@ -74,7 +286,7 @@ void VRView::loadImageRelative(int offset)
 
         QFileInfo selected = files.at((index+offset)%files.length());
         qDebug() << "loading relative image" << selected.fileName();
-        loadPanorama(selected.absoluteFilePath(), m_mode);
+        loadPanorama(selected.absoluteFilePath(), m_current.mode);
     }
 }
 
@@ -95,7 +307,13 @@ void VRView::shutdown()
 {
     makeCurrent();
 
-    delete m_texture;
+    stopVideo();
+
+    releaseTextures(m_current);
+    releaseTextures(m_next);
+
+    if (m_glReady)
+        glDeleteQueries(SAMPLE_QUERY_COUNT, m_sampleQueries);
 
     m_vertexBuffer.destroy();
     m_vao.destroy();
@@ -121,6 +339,8 @@ void VRView::debugMessage(QOpenGLDebugMessage message)
 
 void VRView::initializeGL()
 {
+    startupMark("gl context ready");
+
     initializeOpenGLFunctions();
 
 #ifdef QT_DEBUG
@@ -138,15 +358,18 @@ void VRView::initializeGL()
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_TEXTURE_2D);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-    // compile our shader
+    // compile our shader, linked binaries are cached on disk after the first run. The cube
+    // map conversion isn't needed for the first frame, so it's compiled on first use
     compileShader(m_shader, ":/shaders/unlit.vert", ":/shaders/unlit.frag");
+    startupMark("shaders ready");
 
     // build out sample geometry
     m_vao.create();
     m_vao.bind();
 
-    QVector<GLfloat> points = readObj(":/models/sphere.obj");
+    QVector<GLfloat> points = m_mesh.result();
     m_vertCount = points.length();
     qDebug() << "loaded" << m_vertCount << "verts";
 
@@ -165,10 +388,32 @@ void VRView::initializeGL()
     m_shader.enableAttributeArray("texCoord");
 
     m_shader.setUniformValue("diffuse", 0);
-
-    m_texture = new QOpenGLTexture(QImage(":/textures/uvmap.png"));
+    m_shader.setUniformValue("environment", 1);
+    startupMark("mesh uploaded");
 
     initVR();
+    startupMark("openvr ready");
+
+    glGenQueries(SAMPLE_QUERY_COUNT, m_sampleQueries);
+
+    m_glReady = true;
+
+    if (!m_startupPanorama.isNull())
+    {
+        // still inside initializeGL, the context is already current
+        stagePanorama(m_startupPanorama, m_pendingMode);
+        m_showNext = true;
+        m_startupPanorama = Panorama();
+    }
+    else if (!m_startupVideo.isEmpty())
+    {
+        startVideo(m_startupVideo, m_pendingMode);
+        m_startupVideo.clear();
+    }
+
+    // only worth decoding if nothing else is about to replace it
+    if (m_pendingImage.isEmpty() && m_nextPanorama.isNull())
+        ensurePlaceholder();
 }
 
 void VRView::paintGL()
@@ -177,7 +422,16 @@ void VRView::paintGL()
     {
         updatePoses();
         updateInput();
+    }
+
+    // right after WaitGetPoses, so frames are picked on the compositor's cadence
+    if (m_video)
+        updateVideo();
 
+    beginSampleQuery();
+
+    if (m_hmd)
+    {
         glClearColor(0.15f, 0.15f, 0.18f, 1.0f);
         glViewport(0, 0, m_eyeWidth, m_eyeHeight);
 
@@ -206,6 +460,8 @@ void VRView::paintGL()
     glDisable(GL_MULTISAMPLE);
     renderEye(vr::Eye_Right);
 
+    endSampleQuery();
+
     if (m_hmd)
     {
         vr::VRTextureBounds_t leftRect = { 0.0f, 0.0f, 0.5f, 1.0f };
@@ -218,6 +474,25 @@ void VRView::paintGL()
 
     //vr::VRCompositor()->PostPresentHandoff();
 
+    if (m_firstFrame)
+    {
+        m_firstFrame = false;
+        qint64 elapsed = startupMark(m_hmd ? "first frame submitted to hmd" : "first frame");
+        emit statusMessage(tr("First frame after %1 ms").arg(elapsed));
+    }
+
+    // the first frame is usually blank, this is when the panorama from the command line shows up
+    if (m_startupShown)
+    {
+        m_startupShown = false;
+        qint64 elapsed = startupMark("startup panorama displayed");
+        emit statusMessage(tr("%1 displayed after %2 ms").arg(QFileInfo(m_current.fileName).fileName()).arg(elapsed));
+    }
+
+    // the compositor has this frame, use the slack before the next WaitGetPoses
+    if (!m_nextPanorama.isNull())
+        uploadPending();
+
     m_frames++;
 
     update();
@@ -228,16 +503,438 @@ void VRView::renderEye(vr::Hmd_Eye eye)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
 
+    // nothing loaded yet, e.g. the startup panorama is still decoding
+    if (!m_current.texture && !m_current.cubemap[0])
+        return;
+
     m_vao.bind();
     m_shader.bind();
-    m_texture->bind(0);
 
+    bool cubemap = m_current.cubemap[0] != 0;
+    if (cubemap)
+        m_current.cubemap[eye==vr::Eye_Right && m_current.cubemap[1] ? 1 : 0]->bind(1);
+    else
+        m_current.texture->bind(0);
+
+    m_shader.setUniformValue("cubemap", cubemap);
     m_shader.setUniformValue("transform", viewProjection(eye));
     m_shader.setUniformValue("leftEye", eye==vr::Eye_Left);
-    m_shader.setUniformValue("overUnder", m_mode==VRView::OverUnder);
+    m_shader.setUniformValue("overUnder", m_current.mode==VRView::OverUnder);
+    m_shader.setUniformValue("flipped", m_current.flipped);
+    m_shader.setUniformValue("tonemap", m_current.hdr);
+    m_shader.setUniformValue("exposure", std::pow(2.0f, m_exposure));
     glDrawArrays(GL_TRIANGLES, 0, m_vertCount);
 }
 
+void VRView::beginSampleQuery()
+{
+    GLuint query = m_sampleQueries[m_sampleQueryIndex];
+    QString &path = m_sampleQueryPaths[m_sampleQueryIndex];
+
+    // this query was issued SAMPLE_QUERY_COUNT frames ago, skip it rather than wait if it isn't done
+    if (!path.isEmpty())
+    {
+        GLuint available = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+            // averages are per path, so toggling C or loading an HDR starts a new one
+            if (path != m_samplePath)
+            {
+                m_samplePath = path;
+                m_sampleTime = 0;
+                m_sampleCount = 0;
+            }
+
+            if (m_sampleCount < SAMPLE_LOG_FRAMES)
+            {
+                m_sampleTime += elapsed;
+                m_sampleCount++;
+
+                if (m_sampleCount == SAMPLE_LOG_FRAMES)
+                    qDebug() << "rendering" << m_samplePath << "takes"
+                             << m_sampleTime / 1.0e6 / m_sampleCount << "ms per frame on the gpu";
+            }
+        }
+    }
+
+    path.clear();
+    if (m_current.cubemap[0] || m_current.texture)
+    {
+        path = m_current.hdr ? "RGBA16F" : "RGBA8";
+        path += m_current.cubemap[0] ? " cube map" : " equirectangular";
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void VRView::endSampleQuery()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    m_sampleQueryIndex = (m_sampleQueryIndex + 1) % SAMPLE_QUERY_COUNT;
+}
+
+VRView::Textures VRView::createTextures(const Panorama &panorama, VRMode mode)
+{
+    Textures textures;
+    textures.fileName = panorama.fileName;
+    textures.mode = mode;
+    textures.hdr = panorama.isHdr();
+    textures.width = panorama.width();
+    textures.height = panorama.height();
+
+    QOpenGLTexture *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setSize(textures.width, textures.height);
+    texture->setFormat(textures.hdr ? QOpenGLTexture::RGBA16F : QOpenGLTexture::RGBA8_UNorm);
+    texture->setMipLevels(texture->maximumMipLevels());
+    texture->allocateStorage(QOpenGLTexture::RGBA, textures.hdr ? QOpenGLTexture::Float16 : QOpenGLTexture::UInt8);
+    texture->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+
+    textures.texture = texture;
+    return textures;
+}
+
+void VRView::uploadRows(Textures &textures, const Panorama &panorama, int firstRow, int rows)
+{
+    textures.texture->bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, panorama.width(), rows, GL_RGBA,
+                    panorama.isHdr() ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE, panorama.scanLine(firstRow));
+    textures.texture->release();
+}
+
+// everything after the rows are uploaded, split up so staged panoramas can take a step per
+// frame: source mipmaps, then per eye six cube faces and the cube mipmaps
+bool VRView::finishStep(Textures &textures, int step)
+{
+    if (step == 0)
+    {
+        textures.texture->generateMipMaps();
+        return !beginCubemap(textures);
+    }
+
+    int eyes = textures.cubemap[1] ? 2 : 1;
+    int eye = (step - 1) / 7;
+    int face = (step - 1) % 7;
+
+    if (face < 6)
+        renderCubeFace(textures, eye, face);
+    else
+        textures.cubemap[eye]->generateMipMaps();
+
+    if (step < eyes * 7)
+        return false;
+
+    int faceSize = textures.cubemap[0]->width();
+    qDebug() << "converted to" << eyes << "cube maps of" << faceSize << "x" << faceSize << "in" << step + 1 << "steps,"
+             << eyes * 6 * faceSize * faceSize << "texels instead of"
+             << textures.width * textures.height;
+
+    // the equirectangular source is no longer needed
+    delete textures.texture;
+    textures.texture = 0;
+    return true;
+}
+
+void VRView::releaseTextures(Textures &textures)
+{
+    delete textures.texture;
+    delete textures.cubemap[0];
+    delete textures.cubemap[1];
+    textures = Textures();
+}
+
+void VRView::showTextures(const Textures &textures)
+{
+    stopVideo();
+    releaseTextures(m_current);
+    m_current = textures;
+
+    if (m_current.hdr)
+        emit statusMessage(tr("Loaded %1 (%2x%3 HDR)").arg(QFileInfo(m_current.fileName).fileName())
+                           .arg(m_current.width).arg(m_current.height));
+    else
+        emit statusMessage(tr("Loaded %1 (%2x%3)").arg(QFileInfo(m_current.fileName).fileName())
+                           .arg(m_current.width).arg(m_current.height));
+}
+
+void VRView::uploadPending()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // big panoramas would stall a whole frame, so only send a slice each frame
+    if (m_nextRow < m_nextPanorama.height())
+    {
+        int rows = qMax(1, UPLOAD_BYTES_PER_FRAME / m_nextPanorama.bytesPerLine());
+        rows = qMin(rows, m_nextPanorama.height() - m_nextRow);
+
+        uploadRows(m_next, m_nextPanorama, m_nextRow, rows);
+        m_nextRow += rows;
+
+        m_uploadTime += timer.elapsed();
+        return;
+    }
+
+    // the mipmaps and cube faces are just as heavy, so they get a frame each too
+    bool finished = finishStep(m_next, m_nextStep++);
+    m_uploadTime += timer.elapsed();
+
+    if (!finished)
+        return;
+
+    QString fileName = m_nextPanorama.fileName;
+    m_nextPanorama = Panorama();
+
+    qDebug() << "uploaded" << fileName << "in" << m_uploadTime << "ms";
+    emit panoramaPrepared(fileName, m_uploadTime);
+
+    if (m_showNext)
+    {
+        showTextures(m_next);
+        m_next = Textures();
+        m_showNext = false;
+
+        m_startupShown = m_startupLoad;
+        m_startupLoad = false;
+    }
+}
+
+void VRView::startVideo(const QString &fileName, VRMode mode)
+{
+    VideoDecoder *video = new VideoDecoder(this);
+    if (!video->open(fileName))
+    {
+        m_startupLoad = false;
+        delete video;
+        emit statusMessage(tr("Unable to play %1").arg(QFileInfo(fileName).fileName()));
+        return;
+    }
+
+    Textures textures;
+    textures.fileName = fileName;
+    textures.mode = mode;
+    textures.flipped = true;
+    textures.width = video->width();
+    textures.height = video->height();
+
+    // rewritten every frame, so no mipmaps and no cube map conversion
+    QOpenGLTexture *texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setSize(textures.width, textures.height);
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->setMipLevels(1);
+    texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+    texture->setMinificationFilter(QOpenGLTexture::Linear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+    textures.texture = texture;
+
+    showTextures(textures);
+
+    m_video = video;
+
+    // the decoder writes frames straight into these while they're mapped
+    for (int i=0; i<m_video->frameCount(); i++)
+    {
+        QOpenGLBuffer buffer(QOpenGLBuffer::PixelUnpackBuffer);
+        buffer.create();
+        buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+        buffer.bind();
+        buffer.allocate(textures.width * textures.height * 4);
+        buffer.release();
+
+        m_videoBuffers.append(buffer);
+        mapVideoFrame(i);
+    }
+
+    m_videoClock.invalidate();
+    m_lastVideoPts = -1;
+    m_videoLateFrames = 0;
+
+    m_video->start();
+
+    emit statusMessage(tr("Playing %1 (%2x%3)").arg(QFileInfo(fileName).fileName())
+                       .arg(textures.width).arg(textures.height));
+}
+
+void VRView::stopVideo()
+{
+    if (!m_video)
+        return;
+
+    qDebug() << "video stopped," << m_video->droppedFrames() << "frames dropped,"
+             << m_videoLateFrames << "refreshes waiting on decode";
+
+    delete m_video;
+    m_video = 0;
+
+    // the decode thread has stopped, deleting a mapped buffer unmaps it
+    for (int i=0; i<m_videoBuffers.size(); i++)
+        m_videoBuffers[i].destroy();
+    m_videoBuffers.clear();
+}
+
+void VRView::updateVideo()
+{
+    // the clock starts with the first decoded frame so start up isn't counted as lag
+    if (!m_videoClock.isValid())
+    {
+        m_videoStart = m_video->nextFrameTime();
+        if (m_videoStart < 0)
+            return;
+        m_videoClock.start();
+
+        float sinceVsync = 0.0f;
+        if (m_hmd)
+            m_hmd->GetTimeSinceLastVsync(&sinceVsync, &m_videoStartVsync);
+    }
+
+    // aim for when this frame reaches the display, one refresh after WaitGetPoses
+    qint64 time = m_videoStart + videoClock() + qint64(m_frameTime);
+
+    int index = m_video->acquireFrame(time);
+    if (index < 0)
+    {
+        // nothing new is due, or decode fell behind and we repeat the last frame
+        if (m_lastVideoPts >= 0 && time - m_lastVideoPts > 2 * m_video->frameDuration())
+            m_videoLateFrames++;
+        return;
+    }
+
+    m_lastVideoPts = m_video->frame(index).pts;
+
+    // the decode thread already wrote the pixels, all that's left here is handing them to GL
+    QOpenGLBuffer &buffer = m_videoBuffers[index];
+    buffer.bind();
+    if (buffer.unmap())
+    {
+        // sourced from the bound PBO, so this returns without waiting on the copy
+        m_current.texture->bind();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_current.width, m_current.height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        m_current.texture->release();
+    }
+    buffer.release();
+
+    m_startupShown = m_startupLoad;
+    m_startupLoad = false;
+
+    mapVideoFrame(index);
+}
+
+void VRView::mapVideoFrame(int index)
+{
+    QOpenGLBuffer &buffer = m_videoBuffers[index];
+
+    // invalidating lets the driver hand out fresh storage instead of waiting on the last upload
+    buffer.bind();
+    void *data = buffer.mapRange(0, buffer.size(), QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer);
+    buffer.release();
+
+    if (data)
+        m_video->attachFrame(index, static_cast<uchar*>(data));
+    else
+        qWarning() << "unable to map video frame" << index;
+}
+
+qint64 VRView::videoClock()
+{
+    // count headset refreshes, so frames are picked on the same cadence as WaitGetPoses
+    float sinceVsync = 0.0f;
+    uint64_t vsync = 0;
+    if (m_hmd && m_hmd->GetTimeSinceLastVsync(&sinceVsync, &vsync))
+        return qint64((vsync - m_videoStartVsync) * double(m_frameTime));
+
+    return m_videoClock.elapsed();
+}
+
+bool VRView::beginCubemap(Textures &textures)
+{
+    if (!m_cubemapMode)
+        return false;
+
+    // compiled on first use, and only attempted once
+    if (m_cubeShader.shaders().isEmpty())
+        compileShader(m_cubeShader, ":/shaders/cubeconvert.vert", ":/shaders/cubeconvert.frag");
+
+    if (!m_cubeShader.isLinked())
+        return false;
+
+    QOpenGLTexture *texture = textures.texture;
+    int faceSize = cubemapFaceSize(textures);
+    int eyes = textures.mode==VRView::OverUnder ? 2 : 1;
+
+    // the poles would otherwise blend with the other eye's half
+    texture->setWrapMode(QOpenGLTexture::DirectionT, QOpenGLTexture::ClampToEdge);
+
+    // footprints near the poles are long and thin, so don't blur them along latitude too
+    texture->setMaximumAnisotropy(16.0f);
+
+    for (int eye=0; eye<eyes; eye++)
+    {
+        QOpenGLTexture *cubemap = new QOpenGLTexture(QOpenGLTexture::TargetCubeMap);
+        cubemap->setSize(faceSize, faceSize);
+        cubemap->setFormat(textures.hdr ? QOpenGLTexture::RGBA16F : QOpenGLTexture::RGBA8_UNorm);
+        cubemap->setMipLevels(cubemap->maximumMipLevels());
+        cubemap->allocateStorage();
+        cubemap->setMinificationFilter(QOpenGLTexture::LinearMipMapLinear);
+        cubemap->setMagnificationFilter(QOpenGLTexture::Linear);
+        cubemap->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+        textures.cubemap[eye] = cubemap;
+    }
+
+    return true;
+}
+
+void VRView::renderCubeFace(Textures &textures, int eye, int face)
+{
+    QOpenGLTexture *cubemap = textures.cubemap[eye];
+    int faceSize = cubemap->width();
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemap->textureId(), 0);
+    glViewport(0, 0, faceSize, faceSize);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_MULTISAMPLE);
+
+    m_vao.bind();
+    m_cubeShader.bind();
+    textures.texture->bind(0);
+
+    m_cubeShader.setUniformValue("equirect", 0);
+    m_cubeShader.setUniformValue("overUnder", textures.mode==VRView::OverUnder);
+    m_cubeShader.setUniformValue("leftEye", eye==0);
+    m_cubeShader.setUniformValue("face", face);
+    m_cubeShader.setUniformValue("texelStep", 2.0f / faceSize);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glDeleteFramebuffers(1, &fbo);
+    glEnable(GL_DEPTH_TEST);
+}
+
+int VRView::cubemapFaceSize(const Textures &textures)
+{
+    // without a headset match the horizontal resolution of the source
+    int faceSize = textures.width / 4;
+
+    // each face covers 90 degrees, no point going past the HMD's resolution
+    if (m_pixelsPerDegree > 0.0f)
+        faceSize = qMin(faceSize, qCeil(m_pixelsPerDegree * 90.0f));
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxSize);
+
+    return qBound(1, faceSize, maxSize);
+}
+
 void VRView::resizeGL(int, int)
 {
     // do nothing
@@ -254,6 +951,15 @@ void VRView::keyPressEvent(QKeyEvent *event)
     case Qt::Key_Space:
         loadImageRelative(1);
         break;
+    case Qt::Key_Up:
+        adjustExposure(0.5f);
+        break;
+    case Qt::Key_Down:
+        adjustExposure(-0.5f);
+        break;
+    case Qt::Key_C:
+        setCubemapMode(!m_cubemapMode);
+        break;
     case Qt::Key_Escape:
         QApplication::quit();
         break;
@@ -294,6 +1000,17 @@ void VRView::initVR()
     // setup frame buffers for eyes
     m_hmd->GetRecommendedRenderTargetSize(&m_eyeWidth, &m_eyeHeight);
 
+    // used to size cube maps so we don't store more detail than the display shows
+    float left, right, top, bottom;
+    m_hmd->GetProjectionRaw(vr::Eye_Left, &left, &right, &top, &bottom);
+    float fov = qRadiansToDegrees(std::atan(right) - std::atan(left));
+    if (fov > 0.0f)
+        m_pixelsPerDegree = m_eyeWidth / fov;
+
+    float frequency = m_hmd->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+    if (frequency > 0.0f)
+        m_frameTime = 1000.0f / frequency;
+
     QOpenGLFramebufferObjectFormat buffFormat;
     buffFormat.setAttachment(QOpenGLFramebufferObject::Depth);
     buffFormat.setInternalTextureFormat(GL_RGBA8);
@@ -348,6 +1065,7 @@ void VRView::updateInput()
         //ProcessVREvent( event );
     }
 
+    // loads are queued until after paintGL, they make the context current themselves
     for(vr::TrackedDeviceIndex_t i=0; i<vr::k_unMaxTrackedDeviceCount; i++ )
     {
         vr::VRControllerState_t state;
@@ -357,7 +1075,7 @@ void VRView::updateInput()
             {
                 if (!m_inputNext[i])
                 {
-                    loadImageRelative(1);
+                    QTimer::singleShot(0, this, [this]() { loadImageRelative(1); });
                     m_inputNext[i] = true;
                 }
             }
@@ -370,7 +1088,7 @@ void VRView::updateInput()
             {
                 if (!m_inputPrev[i])
                 {
-                    loadImageRelative(-1);
+                    QTimer::singleShot(0, this, [this]() { loadImageRelative(-1); });
                     m_inputPrev[i] = true;
                 }
             }
@@ -385,11 +1103,12 @@ void VRView::updateInput()
 
 bool VRView::compileShader(QOpenGLShaderProgram &shader, const QString &vertexShaderPath, const QString &fragmentShaderPath)
 {
-    bool result = shader.addShaderFromSourceFile(QOpenGLShader::Vertex, vertexShaderPath);
+    // cacheable shaders let Qt reuse the program binary (glGetProgramBinary) on later runs
+    bool result = shader.addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vertexShaderPath);
     if (!result)
         qCritical() << shader.log();
 
-    result = shader.addShaderFromSourceFile(QOpenGLShader::Fragment, fragmentShaderPath);
+    result = shader.addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, fragmentShaderPath);
     if (!result)
         qCritical() << shader.log();
 
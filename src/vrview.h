@@ -10,7 +10,15 @@
 #include <QOpenGLDebugMessage>
 #include <QOpenGLDebugLogger>
 #include <QOpenGLTexture>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
 #include <openvr.h>
+#include "panorama.h"
+
+// GPU timer queries in flight, results are read a few frames late so we never stall on them
+#define SAMPLE_QUERY_COUNT 4
+
+class VideoDecoder;
 
 
 class VRView : public QOpenGLWidget, protected QOpenGLFunctions_4_1_Core
@@ -28,6 +36,17 @@ public:
 
     void loadPanorama(const QString &fileName, VRMode mode=OverUnder);
     void loadImageRelative(int offset);
+    void adjustExposure(float stops);
+    void setCubemapMode(bool enabled);
+
+    // stage a decoded panorama, it is uploaded a slice per frame until panoramaPrepared.
+    // Refused while an image the user opened is still decoding or uploading
+    bool preparePanorama(const Panorama &panorama, VRMode mode=OverUnder);
+    bool showPrepared(const QString &fileName);
+    void cancelPrepared(const QString &fileName);
+
+    QString currentImage() const;
+    float frameTime() const;
 
     QSize minimumSizeHint() const;
 
@@ -36,6 +55,8 @@ signals:
     void deviceIdentifier(const QString&);
     void frameSwap();
     void statusMessage(const QString&);
+    void panoramaPrepared(const QString &fileName, qint64 uploadTime);
+    void panoramaRequested(const QString &fileName);
 
 public slots:
 
@@ -43,6 +64,7 @@ protected slots:
     void updateFramerate();
     void shutdown();
     void debugMessage(QOpenGLDebugMessage message);
+    void panoramaDecoded();
 
 protected:
     void initializeGL();
@@ -51,10 +73,54 @@ protected:
     void keyPressEvent(QKeyEvent *event);
 
 private:
+    // GPU side of a loaded panorama
+    struct Textures
+    {
+        Textures() : texture(0), mode(None), hdr(false), flipped(false), width(0), height(0)
+        {
+            cubemap[0] = cubemap[1] = 0;
+        }
+
+        // one cube map per eye for over/under panoramas, replaces texture when enabled
+        QOpenGLTexture *texture;
+        QOpenGLTexture *cubemap[2];
+
+        VRMode mode;
+        bool hdr;
+        bool flipped; // rows and columns stored as decoded rather than mirrored
+        int width, height;
+        QString fileName;
+    };
+
     void initVR();
 
     void renderEye(vr::Hmd_Eye eye);
 
+    Textures createTextures(const Panorama &panorama, VRMode mode);
+    void uploadRows(Textures &textures, const Panorama &panorama, int firstRow, int rows);
+    bool finishStep(Textures &textures, int step);
+    void releaseTextures(Textures &textures);
+    void showTextures(const Textures &textures);
+    void uploadPending();
+
+    void startVideo(const QString &fileName, VRMode mode);
+    void stopVideo();
+    void updateVideo();
+    void mapVideoFrame(int index);
+    qint64 videoClock();
+
+    void decodePanoramaAsync(const QString &fileName, VRMode mode);
+    void stagePanorama(const Panorama &panorama, VRMode mode);
+    void releaseStaged();
+    void ensurePlaceholder();
+
+    bool beginCubemap(Textures &textures);
+    void renderCubeFace(Textures &textures, int eye, int face);
+    int cubemapFaceSize(const Textures &textures);
+
+    void beginSampleQuery();
+    void endSampleQuery();
+
     void updatePoses();
 
     void updateInput();
@@ -87,11 +153,45 @@ private:
     QOpenGLDebugLogger *m_logger;
 
     QOpenGLShaderProgram m_shader;
+    QOpenGLShaderProgram m_cubeShader;
     QOpenGLBuffer m_vertexBuffer;
     QOpenGLVertexArrayObject m_vao;
-    QOpenGLTexture *m_texture;
+    QFuture<QVector<GLfloat> > m_mesh;
     int m_vertCount;
 
+    // requests that arrive before initializeGL, e.g. from the command line
+    bool m_glReady;
+    Panorama m_startupPanorama;
+    QString m_startupVideo;
+    bool m_firstFrame;
+    bool m_startupLoad;  // requested before initializeGL and not on screen yet
+    bool m_startupShown; // on screen from this frame, marked once it's submitted
+
+    Textures m_current;
+    Textures m_next;
+    Panorama m_nextPanorama;
+    int m_nextRow;
+    int m_nextStep;
+    qint64 m_uploadTime;
+    bool m_showNext;
+
+    QFutureWatcher<Panorama> *m_decodeWatcher;
+    QString m_pendingImage;
+    VRMode m_pendingMode;
+    float m_exposure;
+
+    VideoDecoder *m_video;
+    QVector<QOpenGLBuffer> m_videoBuffers; // one per decoder frame
+    QElapsedTimer m_videoClock;
+    qint64 m_videoStart;
+    uint64_t m_videoStartVsync;
+    qint64 m_lastVideoPts;
+    int m_videoLateFrames;
+
+    bool m_cubemapMode;
+    float m_pixelsPerDegree;
+    float m_frameTime;
+
     uint32_t m_eyeWidth, m_eyeHeight;
     //FBOHandle *m_leftBuffer, *m_rightBuffer;
     QOpenGLFramebufferObject *m_leftBuffer;
@@ -100,9 +200,15 @@ private:
 
     int m_frames;
 
-    VRMode m_mode;
+    // GPU time spent rendering the eyes, per texture format and sampling path
+    GLuint m_sampleQueries[SAMPLE_QUERY_COUNT];
+    QString m_sampleQueryPaths[SAMPLE_QUERY_COUNT];
+    int m_sampleQueryIndex;
+    QString m_samplePath;
+    GLuint64 m_sampleTime;
+    int m_sampleCount;
+
     QString m_imageDirectory;
-    QString m_currentImage;
 
     bool m_inputNext[vr::k_unMaxTrackedDeviceCount];
     bool m_inputPrev[vr::k_unMaxTrackedDeviceCount];